@@ -12,9 +12,14 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
+#include "SmallVector.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 
 template<typename Action>
@@ -123,10 +128,79 @@ bool merge(ActionRange<Action> const& a,
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// A set of actions, stored as ranges sorted by their front. The ranges never
+// intersect or touch each other, so every set has exactly one representation.
+// Up to four ranges are stored without allocating memory.
 template<typename Action>
 class ActionFilter {
     typedef ActionRange<Action> Range;
-    std::vector<Range> _ranges;
+    
+public:
+    typedef SmallVector<Range, 4> Ranges;
+    
+private:
+    Ranges _ranges;
+    
+    // Appends a range that does not start before the last range, merging it
+    // with the last range if they touch.
+    static void append(Ranges& ranges, Range const& range) {
+        if (!ranges.empty()) {
+            Range& last = ranges.back();
+            // front() - 1 is only evaluated if front() is not the lowest action
+            if (range.front() <= last.back() ||
+                range.front() - 1 <= last.back()) {
+                if (range.back() > last.back()) {
+                    last = Range(last.front(), range.back());
+                }
+                return;
+            }
+        }
+        ranges.push_back(range);
+    }
+    
+    // Merges two sorted sequences of ranges.
+    template<typename A, typename B>
+    static Ranges unite(A const& a, B const& b) {
+        Ranges result;
+        auto i = a.begin();
+        auto j = b.begin();
+        while (i != a.end() || j != b.end()) {
+            if (j == b.end() || (i != a.end() && i->front() <= j->front())) {
+                append(result, *i++);
+            } else {
+                append(result, *j++);
+            }
+        }
+        return result;
+    }
+    
+    // Removes the sorted sequence of ranges b from a.
+    template<typename A, typename B>
+    static Ranges subtract(A const& a, B const& b) {
+        Ranges result;
+        auto j = b.begin();
+        for (Range const& r : a) {
+            while (j != b.end() && j->back() < r.front()) {
+                ++j;
+            }
+            Action front = r.front();
+            bool covered = false;
+            for (auto k = j; k != b.end() && k->front() <= r.back(); ++k) {
+                if (k->front() > front) {
+                    result.push_back(Range(front, k->front() - 1));
+                }
+                if (k->back() >= r.back()) {
+                    covered = true;
+                    break;
+                }
+                front = k->back() + 1;
+            }
+            if (!covered) {
+                result.push_back(Range(front, r.back()));
+            }
+        }
+        return result;
+    }
     
 public:
     ActionFilter() {}
@@ -134,75 +208,73 @@ public:
     ActionFilter(Range const& range) : _ranges{ range } {}
     
     ActionFilter<Action> const& operator = (Range const& range) {
-        _ranges = { range };
+        _ranges.clear();
+        _ranges.push_back(range);
         return *this;
     }
     
-    ActionFilter<Action> const& operator += (Range range) {
-        for (int i = 0; i < _ranges.size(); ++i) {
-            if (merge(_ranges[i], range, range)) {
-                _ranges.erase(_ranges.begin() + i);
-                i--;
-            }
+    ActionFilter<Action> const& operator += (Range const& range) {
+        if (_ranges.empty() || !(range.front() < _ranges.back().front())) {
+            // adding ranges in order takes constant time
+            append(_ranges, range);
+        } else {
+            _ranges = unite(_ranges, Ranges{ range });
         }
-        _ranges.push_back(range);
         return *this;
     }
     
     ActionFilter<Action> const& operator += (ActionFilter<Action> const& filter) {
-        for (auto& r : filter.ranges()) {
-            *this += r;
-        }
+        _ranges = unite(_ranges, filter._ranges);
         return *this;
     }
     
     ActionFilter<Action> const& operator -= (Range const& range) {
-        std::vector<Range> new_ranges;
-        for (auto const& r : _ranges) {
-            if (intersecting(range, r)) {
-                if (range.front() > r.front()) {
-                    new_ranges.push_back(Range(r.front(),
-                                               range.front() - 1));
-                }
-                if (range.back() < r.back()) {
-                    new_ranges.push_back(Range(range.back() + 1,
-                                               r.back()));
-                }
-            } else {
-                new_ranges.push_back(r);
-            }
-        }
-        _ranges = new_ranges;
+        _ranges = subtract(_ranges, Ranges{ range });
         return *this;
     }
     
     ActionFilter<Action> const& operator -= (ActionFilter<Action> const& filter) {
-        for (auto& r : filter.ranges()) {
-            *this -= r;
-        }
+        _ranges = subtract(_ranges, filter._ranges);
         return *this;
     }
     
-    std::vector<Range> const& ranges() const { return _ranges; }
+    Ranges const& ranges() const { return _ranges; }
     
     bool includes(Action const& action) const {
-        for (auto const& r : _ranges) {
-            if (r.includes(action)) {
-                return true;
+        // find the last range starting at or before the action
+        size_t begin = 0;
+        size_t end = _ranges.size();
+        while (end - begin > 1) {
+            size_t middle = (begin + end) / 2;
+            if (_ranges[middle].front() <= action) {
+                begin = middle;
+            } else {
+                end = middle;
             }
         }
-        return false;
+        return begin < _ranges.size() && _ranges[begin].includes(action);
     }
     bool includes(ActionFilter<Action> const& filter) const {
-        return (filter - *this).empty();
+        // every range of the filter has to lie within a single range
+        auto i = _ranges.begin();
+        for (Range const& r : filter._ranges) {
+            while (i != _ranges.end() && i->back() < r.front()) {
+                ++i;
+            }
+            if (i == _ranges.end() ||
+                i->front() > r.front() || i->back() < r.back()) {
+                return false;
+            }
+        }
+        return true;
     }
     
     bool operator == (ActionFilter<Action> const& filter) const {
         if (_ranges.size() != filter._ranges.size()) {
             return false;
         }
-        for (int i = 0; i < _ranges.size(); ++i) {
-            if (_ranges[i] != filter._ranges[i]) {
+        for (size_t i = 0; i < _ranges.size(); ++i) {
+            if (!(_ranges[i] == filter._ranges[i])) {
                 return false;
             }
         }
@@ -261,33 +333,44 @@ ActionFilter<Action> operator - (ActionFilter<Action> const& a,
 }
 
 template<typename Action>
-bool intersecting(ActionFilter<Action> const& a,
-                  ActionFilter<Action> const& b) {
-    for (auto const& r0 : a.ranges()) {
-        for (auto const& r1 : b.ranges()) {
-            if (intersecting(r0, r1)) {
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-template <typename Action>
 ActionFilter<Action> intersection(ActionFilter<Action> const& a,
                                   ActionFilter<Action> const& b) {
-    ActionRange<Action> r(0);
     ActionFilter<Action> result;
-    for (auto const& r0 : a.ranges()) {
-        for (auto const& r1 : b.ranges()) {
-            if (intersection(r0, r1, r)) {
-                result += r;
-            }
+    auto i = a.ranges().begin();
+    auto j = b.ranges().begin();
+    while (i != a.ranges().end() && j != b.ranges().end()) {
+        Action const& front = std::max(i->front(), j->front());
+        Action const& back = std::min(i->back(), j->back());
+        if (front <= back) {
+            result += ActionRange<Action>(front, back);
+        }
+        if (i->back() < j->back()) {
+            ++i;
+        } else {
+            ++j;
         }
     }
     return result;
 }
 
+template<typename Action>
+bool intersecting(ActionFilter<Action> const& a,
+                  ActionFilter<Action> const& b) {
+    auto i = a.ranges().begin();
+    auto j = b.ranges().begin();
+    while (i != a.ranges().end() && j != b.ranges().end()) {
+        if (intersecting(*i, *j)) {
+            return true;
+        }
+        if (i->back() < j->back()) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return false;
+}
+
 template<typename Action>
 std::vector<ActionFilter<Action>> atomize(std::vector<ActionFilter<Action>> const& filters) {
     std::vector<ActionFilter<Action>> result;
@@ -312,6 +395,90 @@ std::vector<ActionFilter<Action>> atomize(std::vector<ActionFilter<Action>> cons
     return result;
 }
 
+// Maps actions to classes of actions. The actions are split into intervals at
+// the bounds of the given ranges, initially each interval forms a class.
+// Actions in the same interval are included by the same ranges.
+template<typename Action>
+class ActionClasses {
+    std::vector<Action> _bounds; // first action of each interval
+    std::vector<int> _classes; // class of each interval
+    std::vector<int> _byte_classes; // direct lookup for single byte actions
+    size_t _count;
+    
+public:
+    ActionClasses(std::vector<ActionRange<Action>> const& ranges)
+    : _bounds{ std::numeric_limits<Action>::lowest() } {
+        for (auto const& r : ranges) {
+            _bounds.push_back(r.front());
+            if (r.back() < std::numeric_limits<Action>::max()) {
+                _bounds.push_back(r.back() + 1);
+            }
+        }
+        std::sort(_bounds.begin(), _bounds.end());
+        _bounds.erase(std::unique(_bounds.begin(), _bounds.end()),
+                      _bounds.end());
+        std::vector<int> classes(_bounds.size());
+        for (size_t i = 0; i < classes.size(); ++i) {
+            classes[i] = int(i);
+        }
+        merge(classes);
+    }
+    
+    // Returns the number of intervals.
+    size_t intervals() const { return _bounds.size(); }
+    
+    // Returns the first action of the interval.
+    Action const& front(size_t interval) const { return _bounds[interval]; }
+    
+    // Returns the interval including the action.
+    size_t interval(Action const& action) const {
+        auto it = std::upper_bound(_bounds.begin(), _bounds.end(), action);
+        return (it - _bounds.begin()) - 1;
+    }
+    
+    // Assigns the intervals to classes, numbered from 0.
+    void merge(std::vector<int> const& classes) {
+        _classes = classes;
+        _count = 0;
+        for (int c : _classes) {
+            _count = std::max(_count, size_t(c + 1));
+        }
+        if (sizeof(Action) == 1) {
+            _byte_classes.resize(256);
+            for (int a = 0; a < 256; ++a) {
+                Action action = static_cast<Action>(a);
+                _byte_classes[a] = _classes[interval(action)];
+            }
+        }
+    }
+    
+    // Returns the class of the interval.
+    int at(size_t interval) const { return _classes[interval]; }
+    
+    // Returns the class of the action.
+    int operator () (Action const& action) const {
+        if (!_byte_classes.empty()) {
+            return _byte_classes[static_cast<unsigned char>(action)];
+        }
+        return _classes[interval(action)];
+    }
+    
+    // Returns the class of every single byte action (indexed as unsigned
+    // char), or nullptr for larger actions.
+    int const* byte_classes() const {
+        return _byte_classes.empty() ? nullptr : _byte_classes.data();
+    }
+    
+    // Returns the number of classes.
+    size_t size() const { return _count; }
+    
+    // Returns the approximate number of bytes used.
+    size_t memory() const {
+        return _bounds.size() * sizeof(Action)
+             + (_classes.size() + _byte_classes.size()) * sizeof(int);
+    }
+}; // ActionClasses
+
 template<typename Action>
 std::ostream& operator << (std::ostream& stream,
                            ActionFilter<Action> const& filter) {
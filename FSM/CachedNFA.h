@@ -0,0 +1,201 @@
+//
+//  CachedNFA.h
+//  FSM
+//
+//  Created by Kristof Niederholtmeyer on 18.10.26.
+//  Copyright (c) 2026 Kristof Niederholtmeyer. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __Parser__CachedNFA__
+#define __Parser__CachedNFA__
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "NFA.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Evaluates a NFA and memoizes its successors, building the parts of the DFA
+// the input actually visits. The sets of NFA states are interned into a
+// bounded number of slots; each slot remembers the successor for every
+// class of actions seen so far. When all slots are taken, a slot is
+// recycled in clock order (second chance).
+//
+// The cache is modified during evaluation, so a CachedNFA must not be shared
+// between threads. Several evaluators may share a CachedNFA: a state shares
+// its set of NFA states with its slot, so a state whose slot was recycled
+// by another evaluator is interned again on its next use.
+template <typename Action>
+class CachedNFA {
+    typedef typename NFA<Action>::EvaluationState StateSet;
+    typedef std::shared_ptr<StateSet const> SharedSet;
+    
+public:
+    // Type definitions for the Evaluator
+    struct EvaluationState {
+        int slot;
+        unsigned generation;
+        SharedSet set;
+    }; // EvaluationState
+    typedef Action EvaluationAction;
+    
+private:
+    // Successor of a slot for a class of actions. 'slot' is -1 if there is no
+    // successor and -2 if it is not known yet.
+    struct Entry {
+        int slot;
+        unsigned generation;
+    }; // Entry
+    
+    struct Slot {
+        SharedSet set;
+        bool accepting;
+        bool referenced;
+        unsigned generation;
+        std::vector<Entry> successors;
+    }; // Slot
+    
+    NFA<Action> _nfa;
+    ActionClasses<Action> _classes;
+    size_t _capacity;
+    
+    mutable std::vector<Slot> _slots;
+    mutable std::map<StateSet, int> _slot_ids;
+    mutable size_t _hand = 0;
+    mutable size_t _hits = 0;
+    mutable size_t _misses = 0;
+    mutable size_t _evictions = 0;
+    
+    static std::vector<ActionRange<Action>> ranges(NFA<Action> const& nfa) {
+        std::vector<ActionRange<Action>> result;
+        for (int s : nfa.states()) {
+            for (auto const& t : nfa.transitions(s)) {
+                result.insert(result.end(), t.filter.ranges().begin(),
+                              t.filter.ranges().end());
+            }
+        }
+        return result;
+    }
+    
+    // Returns the slot of the set of states, recycling a slot other than
+    // 'pinned' if necessary.
+    int intern(StateSet const& set, int pinned) const {
+        auto it = _slot_ids.find(set);
+        if (it != _slot_ids.end()) {
+            _slots[it->second].referenced = true;
+            return it->second;
+        }
+        
+        int slot = int(_slots.size());
+        if (_slots.size() < _capacity) {
+            _slots.push_back({ SharedSet(), false, true, 0, {} });
+        } else {
+            while (true) {
+                _hand = (_hand + 1) % _slots.size();
+                if (int(_hand) == pinned) {
+                    continue;
+                }
+                if (!_slots[_hand].referenced) {
+                    break;
+                }
+                _slots[_hand].referenced = false;
+            }
+            slot = int(_hand);
+            _slot_ids.erase(*_slots[slot].set);
+            _slots[slot].generation++;
+            _slots[slot].referenced = true;
+            _evictions++;
+        }
+        
+        Slot& s = _slots[slot];
+        s.set = std::make_shared<StateSet const>(set);
+        s.accepting = _nfa.accepted(set);
+        s.successors.assign(_classes.size(), { -2, 0 });
+        _slot_ids[set] = slot;
+        return slot;
+    }
+    
+    // Returns true if the slot of the state was not recycled.
+    bool valid(EvaluationState const& state) const {
+        return _slots[state.slot].generation == state.generation;
+    }
+    
+    EvaluationState state(int slot) const {
+        return { slot, _slots[slot].generation, _slots[slot].set };
+    }
+    
+public:
+    // 'capacity' is the maximal number of cached sets of states (at least 2).
+    CachedNFA(NFA<Action> const& nfa, size_t capacity)
+    : _nfa(nfa), _classes(ranges(nfa)), _capacity(std::max<size_t>(capacity, 2)) {}
+    
+    // Finds the states reachable by the action. If no such state exists, the
+    // method returns false and the output stays unchanged.
+    bool successor(EvaluationState const& from,
+                   EvaluationAction const& action,
+                   EvaluationState& output) const {
+        int const c = _classes(action);
+        int const source = valid(from) ? from.slot : intern(*from.set, -1);
+        Entry const e = _slots[source].successors[c];
+        if (e.slot == -1) {
+            _hits++;
+            return false;
+        }
+        if (e.slot >= 0 && _slots[e.slot].generation == e.generation) {
+            _hits++;
+            _slots[e.slot].referenced = true;
+            output = state(e.slot);
+            return true;
+        }
+        
+        _misses++;
+        StateSet set;
+        if (!_nfa.successor(*_slots[source].set, action, set)) {
+            _slots[source].successors[c] = { -1, 0 };
+            return false;
+        }
+        int destination = intern(set, source);
+        _slots[source].successors[c] = { destination, _slots[destination].generation };
+        output = state(destination);
+        return true;
+    }
+    
+    // Returns true if one of the states is an accepting state.
+    bool accepted(EvaluationState const& state) const {
+        if (valid(state)) {
+            return _slots[state.slot].accepting;
+        }
+        return _nfa.accepted(*state.set);
+    }
+    
+    // Returns the initial set of states.
+    EvaluationState initial() const {
+        return state(intern(_nfa.initial(), -1));
+    }
+    
+    // Returns the set of NFA states.
+    StateSet const& set(EvaluationState const& state) const {
+        return *state.set;
+    }
+    
+    // Returns the number of steps answered by the cache.
+    size_t hits() const { return _hits; }
+    
+    // Returns the number of steps that had to evaluate the NFA.
+    size_t misses() const { return _misses; }
+    
+    // Returns the number of recycled slots.
+    size_t evictions() const { return _evictions; }
+}; // CachedNFA
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif /* defined(__Parser__CachedNFA__) */
+
+////////////////////////////////////////////////////////////////////////////////
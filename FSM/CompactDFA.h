@@ -0,0 +1,322 @@
+//
+//  CompactDFA.h
+//  FSM
+//
+//  Created by Kristof Niederholtmeyer on 18.10.26.
+//  Copyright (c) 2026 Kristof Niederholtmeyer. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __Parser__CompactDFA__
+#define __Parser__CompactDFA__
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "DFA.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A read only DFA stored in compressed transition tables, as used by lex and
+// yacc. The actions are mapped to classes of actions that behave the same in
+// every state. Every state has a default destination and stores only the
+// classes leading somewhere else, overlaid in a single comb vector. States
+// with identical rows share them, so an entry is owned by a base:
+//
+//   i = base[state] + class
+//   destination = check[i] == base[state] ? next[i] : fallback[state]
+//
+// A lookup takes constant time and no state needs a full row.
+template <typename Action>
+class CompactDFA {
+    template <typename> friend class MultiDFA;
+    typedef int State;
+    
+public:
+    // Type definitions for the Evaluator
+    typedef State EvaluationState;
+    typedef Action EvaluationAction;
+    
+private:
+    ActionClasses<Action> _classes;
+    
+    std::vector<State> _base;
+    std::vector<State> _fallback;
+    std::vector<State> _next;
+    std::vector<State> _check;
+    std::vector<char> _accepting;
+    
+    // Numbers the states reachable from the initial state densely.
+    static std::vector<int> reachable(DFA<Action> const& dfa,
+                                      std::unordered_map<int, State>& dense) {
+        std::vector<int> states{ dfa.initial() };
+        dense = { { dfa.initial(), 0 } };
+        dense.reserve(dfa.size());
+        for (size_t i = 0; i < states.size(); ++i) {
+            for (auto const& t : dfa.transitions(states[i])) {
+                if (dense.insert({ t.destination, State(states.size()) }).second) {
+                    states.push_back(t.destination);
+                }
+            }
+        }
+        return states;
+    }
+    
+    // Collects the ranges of all transitions of the reachable states.
+    static std::vector<ActionRange<Action>> ranges(DFA<Action> const& dfa) {
+        std::unordered_map<int, State> dense;
+        std::vector<ActionRange<Action>> result;
+        for (int s : reachable(dfa, dense)) {
+            for (auto const& t : dfa.transitions(s)) {
+                result.insert(result.end(), t.filter.ranges().begin(),
+                              t.filter.ranges().end());
+            }
+        }
+        return result;
+    }
+    
+    // The transitions of a state with renumbered destinations.
+    typedef std::vector<std::pair<State, ActionFilter<Action> const*>> Edges;
+    
+    // Fills the destinations of the state for each interval of actions.
+    void row(Edges const& edges, std::vector<State>& result) const {
+        std::fill(result.begin(), result.end(), -1);
+        for (auto const& edge : edges) {
+            State destination = edge.first;
+            for (auto const& r : edge.second->ranges()) {
+                for (size_t i = _classes.interval(r.front());
+                     i < _classes.intervals() && _classes.front(i) <= r.back();
+                     ++i) {
+                    result[i] = destination;
+                }
+            }
+        }
+    }
+    
+public:
+    // Compresses a DFA. The states are renumbered, the initial state stays 0.
+    CompactDFA(DFA<Action> const& dfa)
+    : _classes(ranges(dfa)) {
+        if (!dfa.complete()) {
+            throw std::runtime_error("CompactDFA: the DFA is not complete.");
+        }
+        std::unordered_map<int, State> dense;
+        std::vector<int> const states = reachable(dfa, dense);
+        std::vector<Edges> edges(states.size());
+        for (size_t s = 0; s < states.size(); ++s) {
+            for (auto const& t : dfa.transitions(states[s])) {
+                edges[s].push_back({ dense.find(t.destination)->second, &t.filter });
+            }
+        }
+        
+        // intervals with the same destinations in every state share a class
+        size_t const intervals = _classes.intervals();
+        std::vector<State> destinations(intervals);
+        std::vector<int> interval_classes(intervals, 0);
+        std::vector<std::pair<std::pair<int, State>, size_t>> keys(intervals);
+        for (size_t s = 0; s < states.size(); ++s) {
+            row(edges[s], destinations);
+            for (size_t i = 0; i < intervals; ++i) {
+                keys[i] = { { interval_classes[i], destinations[i] }, i };
+            }
+            std::sort(keys.begin(), keys.end());
+            int refined = -1;
+            for (size_t k = 0; k < intervals; ++k) {
+                if (k == 0 || keys[k].first != keys[k - 1].first) {
+                    refined++;
+                }
+                interval_classes[keys[k].second] = refined;
+            }
+        }
+        _classes.merge(interval_classes);
+        
+        // collect the rows, using the most frequent destination as default
+        std::vector<std::vector<std::pair<int, State>>> rows(states.size());
+        _fallback.assign(states.size(), -1);
+        _accepting.assign(states.size(), false);
+        std::vector<State> classes(_classes.size());
+        std::vector<State> sorted;
+        for (size_t s = 0; s < states.size(); ++s) {
+            _accepting[s] = dfa.accepted(states[s]);
+            row(edges[s], destinations);
+            for (size_t i = 0; i < intervals; ++i) {
+                classes[_classes.at(i)] = destinations[i];
+            }
+            sorted = classes;
+            std::sort(sorted.begin(), sorted.end());
+            size_t most = 0;
+            for (size_t i = 0, j = 0; i < sorted.size(); i = j) {
+                while (j < sorted.size() && sorted[j] == sorted[i]) {
+                    j++;
+                }
+                if (j - i > most) {
+                    most = j - i;
+                    _fallback[s] = sorted[i];
+                }
+            }
+            for (size_t c = 0; c < classes.size(); ++c) {
+                if (classes[c] != _fallback[s]) {
+                    rows[s].push_back({ int(c), classes[c] });
+                }
+            }
+        }
+        
+        // overlay the distinct rows, longest first, at the first position they
+        // fit; states with identical rows share their position
+        std::map<std::vector<std::pair<int, State>>, std::vector<size_t>> groups;
+        for (size_t s = 0; s < states.size(); ++s) {
+            if (!rows[s].empty()) {
+                groups[rows[s]].push_back(s);
+            }
+        }
+        std::vector<decltype(groups.begin())> order;
+        for (auto it = groups.begin(); it != groups.end(); ++it) {
+            order.push_back(it);
+        }
+        std::stable_sort(order.begin(), order.end(), [](decltype(groups.begin()) a,
+                                                        decltype(groups.begin()) b) {
+            return a->first.size() > b->first.size();
+        });
+        
+        // for occupied entries, a later entry that might be free
+        std::vector<size_t> skip;
+        auto free_from = [&](size_t i) {
+            size_t j = i;
+            while (j < _check.size() && _check[j] >= 0) {
+                j = skip[j];
+            }
+            while (i < _check.size() && _check[i] >= 0) {
+                size_t k = skip[i];
+                skip[i] = j;
+                i = k;
+            }
+            return j;
+        };
+        std::vector<char> base_used;
+        _base.assign(states.size(), 0);
+        // a row which does not fit after a number of candidate bases is placed
+        // near the end of the tables, where it fits after at most one candidate
+        // per class
+        size_t const attempts = 16 * _classes.size();
+        for (auto group : order) {
+            auto const& row = group->first;
+            size_t const first = size_t(row.front().first);
+            size_t base = free_from(first) - first;
+            for (size_t attempt = 1; ; ++attempt) {
+                if (attempt == attempts) {
+                    size_t tail = _check.size() - std::min(_check.size(), _classes.size());
+                    base = free_from(std::max(tail, base + first)) - first;
+                }
+                if (base < base_used.size() && base_used[base]) {
+                    base = free_from(base + first + 1) - first;
+                    continue;
+                }
+                bool fits = true;
+                for (auto const& entry : row) {
+                    size_t i = base + entry.first;
+                    if (i < _check.size() && _check[i] >= 0) {
+                        // move the conflicting entry to the next free entry
+                        base = free_from(i) - entry.first;
+                        fits = false;
+                        break;
+                    }
+                }
+                if (fits) {
+                    break;
+                }
+            }
+            if (base >= base_used.size()) {
+                base_used.resize(base + 1, false);
+            }
+            base_used[base] = true;
+            for (auto const& entry : row) {
+                size_t i = base + entry.first;
+                if (i >= _check.size()) {
+                    _check.resize(i + 1, -1);
+                    _next.resize(i + 1, -1);
+                    skip.resize(i + 1, 0);
+                }
+                _check[i] = State(base);
+                _next[i] = entry.second;
+                skip[i] = i + 1;
+            }
+            for (size_t s : group->second) {
+                _base[s] = State(base);
+            }
+        }
+        // states without entries get a base owning no entry
+        size_t const empty = _check.size();
+        for (size_t s = 0; s < states.size(); ++s) {
+            if (rows[s].empty()) {
+                _base[s] = State(empty);
+            }
+        }
+        // make every base + class lookup stay inside the tables
+        _check.resize(empty + _classes.size(), -1);
+        _next.resize(empty + _classes.size(), -1);
+    }
+    
+    // Returns the state reachable by the action or -1 if there is none.
+    State step(State from, Action const& action) const {
+        State base = _base[from];
+        size_t i = base + _classes(action);
+        // load both candidates so the selection compiles without a branch
+        State next = _next[i];
+        State fallback = _fallback[from];
+        return _check[i] == base ? next : fallback;
+    }
+    
+    // Finds the state reachable by the action. If no such state exists, the
+    // method returns false and the output stays unchanged.
+    bool successor(EvaluationState const& from,
+                   EvaluationAction const& action,
+                   EvaluationState& output) const {
+        State destination = step(from, action);
+        if (destination < 0) {
+            return false;
+        }
+        output = destination;
+        return true;
+    }
+    
+    // Returns true if the state is an accepting state.
+    bool accepted(EvaluationState const& state) const {
+        return _accepting[state] != 0;
+    }
+    
+    // Returns the initial state.
+    EvaluationState initial() const {
+        return 0;
+    }
+    
+    // Returns the number of states.
+    size_t size() const {
+        return _base.size();
+    }
+    
+    // Returns the number of action classes.
+    size_t classes() const {
+        return _classes.size();
+    }
+    
+    // Returns the approximate number of bytes used by the tables.
+    size_t memory() const {
+        return (_base.size() + _fallback.size() + _next.size() + _check.size())
+             * sizeof(State)
+             + _classes.memory()
+             + _accepting.size();
+    }
+}; // CompactDFA
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif /* defined(__Parser__CompactDFA__) */
+
+////////////////////////////////////////////////////////////////////////////////
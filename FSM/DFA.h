@@ -12,9 +12,12 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <map>
+#include <stdexcept>
 #include <vector>
 
 #include "NFA.h"
@@ -32,60 +35,201 @@ public:
     typedef State EvaluationState;
     typedef Action EvaluationAction;
     
-private:
     typedef ActionFilter<Action> Filter;
     struct Transition {
         State destination;
         Filter filter;
     }; // Transition
     typedef std::vector<Transition> Transitions;
+    
+private:
     std::map<State, Transitions> _transition_table;
     StateSet _accepting_states;
     
+    // The sets of NFA states represented by the states of a DFA created from
+    // a NFA. They are only kept after the construction if requested, to allow
+    // incremental updates and the evaluation of unexplored states.
+    std::map<State, StateSet> _subsets;
+    std::map<StateSet, State> _subset_states;
+    State _next_state = 0;
+    size_t _size = 0;
+    
+    // The revision of the NFA the DFA represents.
+    size_t _revision = 0;
+    
+    // States whose transitions were not computed because of the state budget.
+    StateSet _unexplored;
+    size_t _max_states = std::numeric_limits<size_t>::max();
+    
+    // Returns the state representing the set of NFA states. A new state is
+    // created and scheduled for exploration if no such state exists yet.
+    State subset_state(NFA<Action> const& nfa,
+                       StateSet const& set,
+                       std::vector<State>& pending) {
+        auto it = _subset_states.find(set);
+        if (it != _subset_states.end()) {
+            return it->second;
+        }
+        State s = _next_state++;
+        _size++;
+        _subsets[s] = set;
+        _subset_states[set] = s;
+        if (nfa.accepted(set)) {
+            _accepting_states.insert(s);
+        }
+        pending.push_back(s);
+        return s;
+    }
+    
+    // (Re)computes the transitions leaving the state. If this would exceed the
+    // state budget, the state is left unexplored and false is returned.
+    bool explore(NFA<Action> const& nfa,
+                 State state,
+                 std::vector<State>& pending) {
+        StateSet const set = _subsets[state];
+        std::vector<std::pair<Filter, StateSet>> successors;
+        for (Filter const& f : nfa.atomic_filters(set)) {
+            StateSet r;
+            if (nfa.successor(set, f, r)) {
+                successors.push_back({ f, r });
+            }
+        }
+        
+        if (_size + successors.size() > _max_states) {
+            std::set<StateSet> created;
+            for (auto const& successor : successors) {
+                if (_subset_states.find(successor.second) == _subset_states.end()) {
+                    created.insert(successor.second);
+                }
+            }
+            if (_size + created.size() > _max_states) {
+                _transition_table.erase(state);
+                _unexplored.insert(state);
+                return false;
+            }
+        }
+        
+        Transitions transitions;
+        for (auto const& successor : successors) {
+            transitions.push_back({
+                subset_state(nfa, successor.second, pending), successor.first
+            });
+        }
+        _transition_table[state] = transitions;
+        _unexplored.erase(state);
+        return true;
+    }
+    
 public:
     DFA() {}
     
-    // DFAs can only be created from a NFA.
-    DFA(NFA<Action> const& nfa) {
-        struct TmpState {
-            State state;
-            StateSet set;
-        }; // TmpState
+    // DFAs can only be created from a NFA. The construction stops creating
+    // states when 'max_states' is reached; the remaining states are left
+    // unexplored (see complete()). The sets of NFA states represented by the
+    // states are only kept if 'keep_subsets' is true (see update()).
+    DFA(NFA<Action> const& nfa,
+        size_t max_states = std::numeric_limits<size_t>::max(),
+        bool keep_subsets = false)
+    : _revision(nfa.revision()), _max_states(std::max<size_t>(max_states, 1)) {
+        std::vector<State> pending;
+        subset_state(nfa, nfa.initial(), pending);
+        for (size_t current = 0; current < pending.size(); ++current) {
+            explore(nfa, pending[current], pending);
+        }
+        if (!keep_subsets) {
+            release_subsets();
+        }
+    }
+    
+    // Drops the sets of NFA states represented by the states. Afterwards
+    // update(), subset() and find_subset() are no longer available.
+    void release_subsets() {
+        _subsets.clear();
+        _subset_states.clear();
+    }
+    
+    // Patches a DFA created from the NFA with 'keep_subsets' after the NFA was
+    // modified. The NFA reports the states modified since the DFA was created
+    // or last updated. Only the states representing such an NFA state and
+    // their predecessors are determinized again. All other states keep their
+    // numbers, so a state of the old DFA stays valid as long as it is still
+    // reachable.
+    void update(NFA<Action> const& nfa) {
+        if (_subsets.empty()) {
+            throw std::runtime_error("DFA: update requires a DFA keeping its subsets.");
+        }
+        StateSet const changed = nfa.modified_since(_revision);
+        _revision = nfa.revision();
         
-        std::vector<TmpState> states{ { 0, nfa.epsilon_closure({ 0 }) } };
-        size_t current = 0;
-        State next_state = 1;
-        std::vector<Filter> filters;
+        // states representing a changed NFA state might be outdated
+        StateSet stale;
+        for (auto const& subset : _subsets) {
+            for (auto s : changed) {
+                if (subset.second.find(s) != subset.second.end()) {
+                    stale.insert(subset.first);
+                    break;
+                }
+            }
+        }
         
-        while (current < states.size()) {
-            filters = nfa.atomic_filters(states[current].set);
-            for (Filter const& f : filters) {
-                StateSet r;
-                if (nfa.successor(states[current].set, f, r)) {
-                    State s = 0;
-                    
-                    bool found = false;
-                    for (auto const& t : states) {
-                        if (t.set == r) {
-                            found = true;
-                            s = t.state;
-                        }
-                    }
-                    
-                    if (!found) {
-                        s = next_state++;
-                        if (nfa.accepted(r)) {
-                            _accepting_states.insert(s);
-                        }
-                        states.push_back({ s, r });
-                    }
-                    
-                    _transition_table[states[current].state].push_back({
-                        s, f
-                    });
+        // the closure of the transitions leading to them might have changed
+        StateSet dirty = stale;
+        for (auto const& transitions : _transition_table) {
+            for (Transition const& t : transitions.second) {
+                if (stale.find(t.destination) != stale.end()) {
+                    dirty.insert(transitions.first);
                 }
             }
-            current++;
+        }
+        
+        if (stale.find(0) != stale.end()) {
+            StateSet set = nfa.initial();
+            if (set != _subsets[0]) {
+                auto it = _subset_states.find(_subsets[0]);
+                if (it != _subset_states.end() && it->second == 0) {
+                    _subset_states.erase(it);
+                }
+                _subsets[0] = set;
+                _subset_states[set] = 0;
+            }
+        }
+        for (auto s : stale) {
+            if (nfa.accepted(_subsets[s])) {
+                _accepting_states.insert(s);
+            } else {
+                _accepting_states.erase(s);
+            }
+        }
+        
+        std::vector<State> pending(dirty.begin(), dirty.end());
+        for (size_t current = 0; current < pending.size(); ++current) {
+            explore(nfa, pending[current], pending);
+        }
+        
+        // drop the states that are no longer reachable
+        StateSet reachable{ 0 };
+        std::vector<State> queue{ 0 };
+        for (size_t current = 0; current < queue.size(); ++current) {
+            for (Transition const& t : transitions(queue[current])) {
+                if (reachable.insert(t.destination).second) {
+                    queue.push_back(t.destination);
+                }
+            }
+        }
+        for (auto it = _subsets.begin(); it != _subsets.end();) {
+            if (reachable.find(it->first) != reachable.end()) {
+                ++it;
+                continue;
+            }
+            auto index = _subset_states.find(it->second);
+            if (index != _subset_states.end() && index->second == it->first) {
+                _subset_states.erase(index);
+            }
+            _transition_table.erase(it->first);
+            _accepting_states.erase(it->first);
+            _unexplored.erase(it->first);
+            _size--;
+            it = _subsets.erase(it);
         }
     }
     
@@ -154,6 +298,169 @@ public:
         return _accepting_states.find(state) != _accepting_states.end();
     }
     
+    // Returns false if the construction from a NFA ran out of states. The
+    // transitions of unexplored states are missing, such a DFA has to be
+    // evaluated together with its NFA (see HybridFSM).
+    bool complete() const {
+        return _unexplored.empty();
+    }
+    
+    // Returns true if the transitions leaving the state are known.
+    bool explored(State state) const {
+        return _unexplored.find(state) == _unexplored.end();
+    }
+    
+    // Returns the set of NFA states represented by the state of a DFA created
+    // from a NFA with 'keep_subsets'.
+    StateSet const& subset(State state) const {
+        return _subsets.at(state);
+    }
+    
+    // Returns the state representing the set of NFA states or -1 if there is
+    // no such state or the subsets were not kept.
+    State find_subset(StateSet const& set) const {
+        auto it = _subset_states.find(set);
+        if (it == _subset_states.end()) {
+            return -1;
+        }
+        return it->second;
+    }
+    
+    // Returns the number of states of a DFA created from a NFA.
+    size_t size() const {
+        return _size;
+    }
+    
+    // Returns the transitions leaving the state.
+    Transitions const& transitions(State state) const {
+        static Transitions const none;
+        auto it = _transition_table.find(state);
+        if (it == _transition_table.end()) {
+            return none;
+        }
+        return it->second;
+    }
+    
+    // Creates an equivalent DFA with the minimal number of states. States that
+    // are unreachable or can never lead to an accepting state are dropped.
+    // The DFA has to be complete.
+    DFA<Action> minimized() const {
+        if (!complete()) {
+            throw std::runtime_error("DFA: minimization requires a complete DFA.");
+        }
+        
+        // collect the reachable states
+        std::vector<State> states{ 0 };
+        std::map<State, size_t> index{ { 0, 0 } };
+        for (size_t i = 0; i < states.size(); ++i) {
+            for (Transition const& t : transitions(states[i])) {
+                if (index.find(t.destination) == index.end()) {
+                    index[t.destination] = states.size();
+                    states.push_back(t.destination);
+                }
+            }
+        }
+        
+        // keep only the states leading to an accepting state
+        std::vector<bool> alive(states.size(), false);
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t i = 0; i < states.size(); ++i) {
+                if (alive[i]) {
+                    continue;
+                }
+                if (accepted(states[i])) {
+                    alive[i] = true;
+                } else {
+                    for (Transition const& t : transitions(states[i])) {
+                        if (alive[index[t.destination]]) {
+                            alive[i] = true;
+                            break;
+                        }
+                    }
+                }
+                changed = changed || alive[i];
+            }
+        }
+        
+        // refine the partition until equivalent states share a block
+        typedef std::vector<std::pair<int, std::pair<Action, Action>>> Signature;
+        std::vector<int> block(states.size(), -1);
+        for (size_t i = 0; i < states.size(); ++i) {
+            if (alive[i]) {
+                block[i] = accepted(states[i]) ? 1 : 0;
+            }
+        }
+        size_t block_count = 0;
+        while (true) {
+            std::map<std::pair<int, Signature>, int> blocks;
+            std::vector<int> new_block(states.size(), -1);
+            for (size_t i = 0; i < states.size(); ++i) {
+                if (!alive[i]) {
+                    continue;
+                }
+                std::map<int, Filter> targets;
+                for (Transition const& t : transitions(states[i])) {
+                    int b = block[index[t.destination]];
+                    if (b >= 0) {
+                        targets[b] += t.filter;
+                    }
+                }
+                Signature signature;
+                for (auto const& target : targets) {
+                    for (auto const& r : target.second.ranges()) {
+                        signature.push_back({ target.first,
+                            { r.front(), r.back() } });
+                    }
+                }
+                std::sort(signature.begin(), signature.end());
+                auto key = std::make_pair(block[i], signature);
+                auto it = blocks.find(key);
+                if (it == blocks.end()) {
+                    it = blocks.insert({ key, int(blocks.size()) }).first;
+                }
+                new_block[i] = it->second;
+            }
+            block = new_block;
+            if (blocks.size() == block_count) {
+                break;
+            }
+            block_count = blocks.size();
+        }
+        
+        // build the quotient automaton, numbering the initial block 0
+        DFA<Action> result;
+        if (!alive[0]) {
+            return result;
+        }
+        std::map<int, State> renumber{ { block[0], 0 } };
+        StateSet accepting_states;
+        for (size_t i = 0; i < states.size(); ++i) {
+            if (alive[i] && renumber.find(block[i]) == renumber.end()) {
+                State s = State(renumber.size());
+                renumber[block[i]] = s;
+            }
+        }
+        for (size_t i = 0; i < states.size(); ++i) {
+            if (!alive[i]) {
+                continue;
+            }
+            State source = renumber[block[i]];
+            if (accepted(states[i])) {
+                accepting_states.insert(source);
+            }
+            for (Transition const& t : transitions(states[i])) {
+                int b = block[index[t.destination]];
+                if (b >= 0) {
+                    result.add_transition(source, t.filter, renumber[b]);
+                }
+            }
+        }
+        result.set_accepting_states(accepting_states);
+        return result;
+    }
+    
     // Returns the initial state.
     EvaluationState initial() const {
         return 0;
@@ -187,6 +494,131 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+typedef enum {
+    ProductIntersection,
+    ProductUnion,
+    ProductDifference
+} ProductOperation;
+
+// Combines two DFAs into one by running them side by side. Only the pairs of
+// states reachable from the initial pair are created. A missing transition
+// corresponds to the implicit (non accepting) dead state, represented by -1.
+// Both DFAs have to be complete.
+template<typename Action>
+DFA<Action> product(DFA<Action> const& a,
+                    DFA<Action> const& b,
+                    ProductOperation operation,
+                    bool minimize = false) {
+    typedef std::pair<int, int> Pair;
+    typedef ActionFilter<Action> Filter;
+    
+    if (!a.complete() || !b.complete()) {
+        throw std::runtime_error("DFA: product requires complete DFAs.");
+    }
+    
+    auto accepted = [&](Pair const& p) {
+        bool in_a = p.first >= 0 && a.accepted(p.first);
+        bool in_b = p.second >= 0 && b.accepted(p.second);
+        switch (operation) {
+            case ProductIntersection: return in_a && in_b;
+            case ProductUnion: return in_a || in_b;
+            case ProductDifference: return in_a && !in_b;
+        }
+        return false;
+    };
+    auto dead = [&](Pair const& p) {
+        switch (operation) {
+            case ProductIntersection: return p.first < 0 || p.second < 0;
+            case ProductUnion: return p.first < 0 && p.second < 0;
+            case ProductDifference: return p.first < 0;
+        }
+        return true;
+    };
+    
+    DFA<Action> result;
+    std::set<int> accepting_states;
+    std::vector<Pair> pairs{ { a.initial(), b.initial() } };
+    std::map<Pair, int> states{ { pairs[0], 0 } };
+    if (accepted(pairs[0])) {
+        accepting_states.insert(0);
+    }
+    
+    for (size_t current = 0; current < pairs.size(); ++current) {
+        Pair const p = pairs[current];
+        std::vector<Filter> filters;
+        if (p.first >= 0) {
+            for (auto const& t : a.transitions(p.first)) {
+                filters.push_back(t.filter);
+            }
+        }
+        if (p.second >= 0) {
+            for (auto const& t : b.transitions(p.second)) {
+                filters.push_back(t.filter);
+            }
+        }
+        for (Filter const& f : atomize(filters)) {
+            // atoms never straddle a transition, any member is representative
+            Action const& action = f.ranges().front().front();
+            Pair next(-1, -1);
+            if (p.first >= 0) {
+                a.successor(p.first, action, next.first);
+            }
+            if (p.second >= 0) {
+                b.successor(p.second, action, next.second);
+            }
+            if (dead(next)) {
+                continue;
+            }
+            auto it = states.find(next);
+            if (it == states.end()) {
+                it = states.insert({ next, int(pairs.size()) }).first;
+                if (accepted(next)) {
+                    accepting_states.insert(it->second);
+                }
+                pairs.push_back(next);
+            }
+            result.add_transition(int(current), f, it->second);
+        }
+    }
+    
+    result.set_accepting_states(accepting_states);
+    return minimize ? result.minimized() : result;
+}
+
+// Accepts every sequence of actions that both automata accept.
+template<typename Action>
+DFA<Action> intersection(DFA<Action> const& a,
+                         DFA<Action> const& b) {
+    return product(a, b, ProductIntersection);
+}
+
+// Accepts every sequence of actions that either automaton accepts.
+template<typename Action>
+DFA<Action> operator + (DFA<Action> const& a,
+                        DFA<Action> const& b) {
+    return product(a, b, ProductUnion);
+}
+
+// Accepts every sequence of actions that a accepts but b does not.
+template<typename Action>
+DFA<Action> operator - (DFA<Action> const& a,
+                        DFA<Action> const& b) {
+    return product(a, b, ProductDifference);
+}
+
+// Accepts every sequence of actions from the alphabet the automaton rejects.
+template<typename Action>
+DFA<Action> complement(DFA<Action> const& a,
+                       ActionFilter<Action> const& alphabet,
+                       bool minimize = false) {
+    DFA<Action> universe;
+    universe.add_transition(0, alphabet, 0);
+    universe.set_accepting_states({ 0 });
+    return product(universe, a, ProductDifference, minimize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 #endif /* defined(__Parser__DFA__) */
 
 ////////////////////////////////////////////////////////////////////////////////
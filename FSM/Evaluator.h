@@ -21,27 +21,46 @@ class Evaluator {
     typedef typename FSM::EvaluationState State;
     typedef typename FSM::EvaluationAction Action;
     
-    FSM const& _fsm;
+    FSM const* _fsm;
     State _state;
     
+    // Automata providing reset(State&) reset the state in place, which lets
+    // them keep the memory the state owns.
+    template <typename F>
+    static auto reset_state(F const& fsm, State& state, int)
+    -> decltype(fsm.reset(state)) {
+        fsm.reset(state);
+    }
+    
+    template <typename F>
+    static void reset_state(F const& fsm, State& state, long) {
+        state = fsm.initial();
+    }
+    
 public:
     Evaluator(FSM const& fsm)
-    : _fsm(fsm), _state(fsm.initial()) {}
+    : _fsm(&fsm), _state(fsm.initial()) {}
     
     // Perform an action on the automat. Returns false if the action is not
     // accepted. In this case the internal state stays unchanged.
     bool perform(Action const& action) {
-        return _fsm.successor(_state, action, _state);
+        return _fsm->successor(_state, action, _state);
     }
     
     // Returns true if the automat is currently in an accepting state.
     bool accepted() const {
-        return _fsm.accepted(_state);
+        return _fsm->accepted(_state);
     }
     
     // Reset the automat to its initial state.
     void reset() {
-        _state = _fsm.initial();
+        reset_state(*_fsm, _state, 0);
+    }
+    
+    // Switch to another automat and reset to its initial state.
+    void reset(FSM const& fsm) {
+        _fsm = &fsm;
+        reset_state(fsm, _state, 0);
     }
     
     State const& state() const {
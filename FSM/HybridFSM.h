@@ -0,0 +1,99 @@
+//
+//  HybridFSM.h
+//  FSM
+//
+//  Created by Kristof Niederholtmeyer on 18.10.26.
+//  Copyright (c) 2026 Kristof Niederholtmeyer. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __Parser__HybridFSM__
+#define __Parser__HybridFSM__
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "NFA.h"
+#include "DFA.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A DFA created with a limited number of states, which falls back to the
+// evaluation of the NFA wherever the DFA was not explored. The evaluation
+// switches back to the DFA as soon as the NFA reaches a set of states the DFA
+// represents.
+template <typename Action>
+class HybridFSM {
+    typedef typename NFA<Action>::EvaluationState StateSet;
+    
+public:
+    // Type definitions for the Evaluator
+    struct EvaluationState {
+        int state; // The DFA state or -1 while the NFA is evaluated
+        StateSet set; // The NFA states while the NFA is evaluated
+    }; // EvaluationState
+    typedef Action EvaluationAction;
+    
+private:
+    NFA<Action> _nfa;
+    DFA<Action> _dfa;
+    
+    EvaluationState from_set(StateSet const& set) const {
+        int state = _dfa.find_subset(set);
+        if (state >= 0) {
+            return { state, StateSet() };
+        }
+        return { -1, set };
+    }
+    
+public:
+    HybridFSM(NFA<Action> const& nfa, size_t max_states)
+    : _nfa(nfa), _dfa(nfa, max_states, true) {}
+    
+    DFA<Action> const& dfa() const { return _dfa; }
+    NFA<Action> const& nfa() const { return _nfa; }
+    
+    // Finds the state reachable by the action. If no such state exists, the
+    // method returns false and the output stays unchanged.
+    bool successor(EvaluationState const& from,
+                   EvaluationAction const& action,
+                   EvaluationState& output) const {
+        if (from.state >= 0 && _dfa.explored(from.state)) {
+            int state = 0;
+            if (!_dfa.successor(from.state, action, state)) {
+                return false;
+            }
+            output.state = state;
+            output.set.clear();
+            return true;
+        }
+        
+        StateSet set;
+        if (!_nfa.successor(from.state >= 0 ? _dfa.subset(from.state) : from.set,
+                            action, set)) {
+            return false;
+        }
+        output = from_set(set);
+        return true;
+    }
+    
+    // Returns true if the state is an accepting state.
+    bool accepted(EvaluationState const& state) const {
+        if (state.state >= 0) {
+            return _dfa.accepted(state.state);
+        }
+        return _nfa.accepted(state.set);
+    }
+    
+    // Returns the initial state.
+    EvaluationState initial() const {
+        return { _dfa.initial(), StateSet() };
+    }
+}; // HybridFSM
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif /* defined(__Parser__HybridFSM__) */
+
+////////////////////////////////////////////////////////////////////////////////
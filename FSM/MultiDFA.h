@@ -0,0 +1,209 @@
+//
+//  MultiDFA.h
+//  FSM
+//
+//  Created by Kristof Niederholtmeyer on 18.10.26.
+//  Copyright (c) 2026 Kristof Niederholtmeyer. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __Parser__MultiDFA__
+#define __Parser__MultiDFA__
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <vector>
+
+#include "CompactDFA.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Runs several independent DFAs over the same input in a single pass.
+//
+// The input is read once, in chunks small enough to stay in the L1 cache.
+// The DFAs run over each chunk in groups of four, advanced in lockstep with
+// their states held in registers. The table lookups of a group do not depend
+// on each other, so the processor overlaps their memory accesses instead of
+// waiting for one lookup after another.
+template <typename Action>
+class MultiDFA {
+    static size_t const Chunk = 4096;
+    
+    // The tables of a running DFA and its progress.
+    struct Lane {
+        ActionClasses<Action> const* classes;
+        int const* byte_classes;
+        int const* base;
+        int const* check;
+        int const* next;
+        int const* fallback;
+        char const* accepting;
+        int state;
+        size_t longest;
+        size_t index;
+    }; // Lane
+    
+    std::vector<CompactDFA<Action> const*> _dfas;
+    
+    static int step(Lane const& lane, int state, Action const& action) {
+        int c = sizeof(Action) == 1
+              ? lane.byte_classes[static_cast<unsigned char>(action)]
+              : (*lane.classes)(action);
+        int base = lane.base[state];
+        size_t i = base + c;
+        int next = lane.next[i];
+        int fallback = lane.fallback[state];
+        return lane.check[i] == base ? next : fallback;
+    }
+    
+    // Advances the lanes over the actions up to the first action one of them
+    // does not accept. Returns the number of actions performed.
+    template <int G>
+    static size_t run(Lane* lanes,
+                      Action const* actions,
+                      size_t count,
+                      size_t position) {
+        int states[G];
+        size_t longest[G];
+        for (int g = 0; g < G; ++g) {
+            states[g] = lanes[g].state;
+            longest[g] = lanes[g].longest;
+        }
+        size_t i = 0;
+        for (; i < count; ++i) {
+            int next[G];
+            int stuck = 0;
+            // the lanes only run in parallel if they are fully unrolled
+            #pragma GCC unroll 4
+            for (int g = 0; g < G; ++g) {
+                next[g] = step(lanes[g], states[g], actions[i]);
+                stuck |= next[g];
+            }
+            if (stuck < 0) {
+                break;
+            }
+            #pragma GCC unroll 4
+            for (int g = 0; g < G; ++g) {
+                states[g] = next[g];
+                longest[g] = lanes[g].accepting[next[g]] ? position + i + 1
+                                                         : longest[g];
+            }
+        }
+        for (int g = 0; g < G; ++g) {
+            lanes[g].state = states[g];
+            lanes[g].longest = longest[g];
+        }
+        return i;
+    }
+    
+    static size_t run(Lane* lanes,
+                      size_t size,
+                      Action const* actions,
+                      size_t count,
+                      size_t position) {
+        switch (size) {
+            case 1: return run<1>(lanes, actions, count, position);
+            case 2: return run<2>(lanes, actions, count, position);
+            case 3: return run<3>(lanes, actions, count, position);
+            default: return run<4>(lanes, actions, count, position);
+        }
+    }
+    
+public:
+    static size_t const npos = size_t(-1);
+    
+    struct Result {
+        int state; // The state after the last performed action
+        size_t length; // The number of actions performed
+        size_t longest; // The length of the longest accepted prefix or npos
+    }; // Result
+    
+    MultiDFA(std::vector<CompactDFA<Action> const*> const& dfas)
+    : _dfas(dfas) {}
+    
+    size_t size() const { return _dfas.size(); }
+    
+    // Evaluates every DFA on the input until it does not accept an action, as
+    // an Evaluator would. The results are stored in the order of the DFAs.
+    template <typename Iterator>
+    void scan(Iterator first,
+              Iterator last,
+              std::vector<Result>& results) const {
+        std::vector<Lane> lanes;
+        for (size_t k = 0; k < _dfas.size(); ++k) {
+            CompactDFA<Action> const& dfa = *_dfas[k];
+            int state = dfa.initial();
+            lanes.push_back({
+                &dfa._classes, dfa._classes.byte_classes(), dfa._base.data(),
+                dfa._check.data(), dfa._next.data(), dfa._fallback.data(),
+                dfa._accepting.data(), state,
+                dfa.accepted(state) ? 0 : npos, k
+            });
+        }
+        results.assign(_dfas.size(), { 0, 0, npos });
+        
+        std::vector<Action> buffer(Chunk);
+        size_t position = 0;
+        while (!lanes.empty() && first != last) {
+            size_t count = 0;
+            while (count < Chunk && first != last) {
+                buffer[count++] = *first++;
+            }
+            
+            size_t running = 0;
+            for (size_t g = 0; g < lanes.size(); g += 4) {
+                Lane group[4];
+                size_t size = std::min<size_t>(4, lanes.size() - g);
+                std::copy(lanes.begin() + g, lanes.begin() + g + size, group);
+                
+                size_t offset = 0;
+                while (size > 0 && offset < count) {
+                    offset += run(group, size, buffer.data() + offset,
+                                  count - offset, position + offset);
+                    if (offset == count) {
+                        break;
+                    }
+                    // at least one lane does not accept this action
+                    for (size_t i = 0; i < size;) {
+                        Lane& lane = group[i];
+                        int state = step(lane, lane.state, buffer[offset]);
+                        if (state < 0) {
+                            results[lane.index] = {
+                                lane.state, position + offset, lane.longest
+                            };
+                            lane = group[--size];
+                            continue;
+                        }
+                        lane.state = state;
+                        if (lane.accepting[state]) {
+                            lane.longest = position + offset + 1;
+                        }
+                        ++i;
+                    }
+                    offset++;
+                }
+                
+                // lanes are only moved towards the front, keep the survivors
+                for (size_t i = 0; i < size; ++i) {
+                    lanes[running++] = group[i];
+                }
+            }
+            lanes.resize(running, lanes.front());
+            position += count;
+        }
+        
+        for (Lane const& lane : lanes) {
+            results[lane.index] = { lane.state, position, lane.longest };
+        }
+    }
+}; // MultiDFA
+
+template <typename Action>
+size_t const MultiDFA<Action>::npos;
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif /* defined(__Parser__MultiDFA__) */
+
+////////////////////////////////////////////////////////////////////////////////
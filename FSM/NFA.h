@@ -12,7 +12,9 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <set>
 #include <sstream>
@@ -32,16 +34,28 @@ public:
     typedef StateSet EvaluationState;
     typedef Action EvaluationAction;
     
-private:
     typedef ActionFilter<Action> Filter;
     struct Transition {
         State destination;
         bool epsilon;
         Filter filter;
+        int tag; // Tag recorded by an epsilon transition or -1
     }; // Transition
     typedef std::vector<Transition> Transitions;
+    
+private:
     std::map<State, Transitions> _transition_table;
     StateSet _accepting_states;
+    int _tag_count = 0;
+    
+    // The revision at which the transitions leaving a state or its acceptance
+    // changed last. Used by DFA::update() to find the states to redo.
+    std::map<State, size_t> _modified;
+    size_t _revision = 0;
+    
+    void modified(State state) {
+        _modified[state] = ++_revision;
+    }
     
 public:
     typedef enum {
@@ -60,10 +74,12 @@ public:
         for (Transition& t : transitions) {
             if (t.destination == destination && !t.epsilon) {
                 t.filter += filter;
+                modified(source);
                 return Good;
             }
         }
-        transitions.push_back({ destination, false, filter });
+        transitions.push_back({ destination, false, filter, -1 });
+        modified(source);
         return Good;
     }
     
@@ -72,19 +88,107 @@ public:
                                        State destination) {
         Transitions& transitions = _transition_table[source];
         for (Transition& t : transitions) {
-            if (t.destination == destination && t.epsilon) {
+            if (t.destination == destination && t.epsilon && t.tag < 0) {
+                return Good;
+            }
+        }
+        transitions.push_back({ destination, true, Filter(), -1 });
+        modified(source);
+        return Good;
+    }
+    
+    // Adds a tagged epsilon transition to the NFA. Evaluated by a TaggedDFA,
+    // passing it records the current position in the input as the tag's
+    // value. Everywhere else it behaves like an epsilon transition. By
+    // convention, capture group n starts at tag 2n and ends at tag 2n+1.
+    AddTransitionResult add_tagged_transition(State source,
+                                              int tag,
+                                              State destination) {
+        Transitions& transitions = _transition_table[source];
+        for (Transition& t : transitions) {
+            if (t.destination == destination && t.epsilon && t.tag == tag) {
                 return Good;
             }
         }
-        transitions.push_back({ destination, true, Filter() });
+        transitions.push_back({ destination, true, Filter(), tag });
+        _tag_count = std::max(_tag_count, tag + 1);
+        modified(source);
         return Good;
     }
     
+    // Removes the actions in the filter from a filtered transition. Returns
+    // false if no such transition exists.
+    bool remove_transition(State source,
+                           Filter const& filter,
+                           State destination) {
+        auto it = _transition_table.find(source);
+        if (it == _transition_table.end()) {
+            return false;
+        }
+        Transitions& transitions = it->second;
+        for (auto t = transitions.begin(); t != transitions.end(); ++t) {
+            if (t->destination == destination && !t->epsilon) {
+                t->filter -= filter;
+                if (t->filter.empty()) {
+                    transitions.erase(t);
+                }
+                modified(source);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // Removes an epsilon transition from the NFA. Returns false if no such
+    // transition exists.
+    bool remove_transition(State source,
+                           State destination) {
+        auto it = _transition_table.find(source);
+        if (it == _transition_table.end()) {
+            return false;
+        }
+        Transitions& transitions = it->second;
+        for (auto t = transitions.begin(); t != transitions.end(); ++t) {
+            if (t->destination == destination && t->epsilon && t->tag < 0) {
+                transitions.erase(t);
+                modified(source);
+                return true;
+            }
+        }
+        return false;
+    }
+    
     // Sets the set of accepting states.
     void set_accepting_states(StateSet const& accepting_states) {
+        StateSet changed;
+        std::set_symmetric_difference(_accepting_states.begin(),
+                                      _accepting_states.end(),
+                                      accepting_states.begin(),
+                                      accepting_states.end(),
+                                      std::inserter(changed, changed.end()));
+        for (auto s : changed) {
+            modified(s);
+        }
         _accepting_states = accepting_states;
     }
     
+    // Returns a number that grows with every modification of the NFA.
+    size_t revision() const {
+        return _revision;
+    }
+    
+    // Returns the states whose outgoing transitions or acceptance changed
+    // after the given revision.
+    StateSet modified_since(size_t revision) const {
+        StateSet result;
+        for (auto const& m : _modified) {
+            if (m.second > revision) {
+                result.insert(m.first);
+            }
+        }
+        return result;
+    }
+    
     // Returns a set of all states that can be reached by epsilon transitions
     // from a state in 'set'.
     EvaluationState epsilon_closure(EvaluationState const& set) const {
@@ -182,6 +286,39 @@ public:
         return false;
     }
     
+    // Returns the transitions leaving the state in order of priority.
+    Transitions const& transitions(State state) const {
+        static Transitions const none;
+        auto it = _transition_table.find(state);
+        if (it == _transition_table.end()) {
+            return none;
+        }
+        return it->second;
+    }
+    
+    // Returns all states used by the NFA, including the initial state.
+    StateSet states() const {
+        StateSet result = _accepting_states;
+        result.insert(0);
+        for (auto const& transitions : _transition_table) {
+            result.insert(transitions.first);
+            for (auto const& t : transitions.second) {
+                result.insert(t.destination);
+            }
+        }
+        return result;
+    }
+    
+    // Returns the set of accepting states.
+    StateSet const& accepting_states() const {
+        return _accepting_states;
+    }
+    
+    // Returns the number of tags used by tagged transitions.
+    int tags() const {
+        return _tag_count;
+    }
+    
     // Returns the initial set of states.
     EvaluationState initial() const {
         return epsilon_closure({ 0 });
@@ -206,6 +343,9 @@ public:
                 ss << "  S" << start << " -> S" << end << " [ label = \"";
                 if (t.epsilon) {
                     ss << "&#949;";
+                    if (t.tag >= 0) {
+                        ss << " t" << t.tag;
+                    }
                 } else {
                     ss << t.filter;
                 }
@@ -0,0 +1,190 @@
+//
+//  Search.h
+//  FSM
+//
+//  Created by Kristof Niederholtmeyer on 18.10.26.
+//  Copyright (c) 2026 Kristof Niederholtmeyer. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __Parser__Search__
+#define __Parser__Search__
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "NFA.h"
+#include "DFA.h"
+#include "CompactDFA.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Finds the matches of a NFA anywhere in an input (unanchored search).
+//
+// A single forward pass over the input evaluates the DFA of '.*' followed by
+// the NFA, which is accepting whenever a match ends. Likewise, a single
+// backward pass evaluates the DFA of '.*' followed by the reversed NFA, which
+// is accepting whenever a match begins. find_all() reports the leftmost
+// longest matches that do not overlap: it takes the first start not covered
+// by the previous match and runs the DFA of the NFA forward from there.
+template <typename Action>
+class Search {
+    CompactDFA<Action> _forward;
+    CompactDFA<Action> _reverse;
+    CompactDFA<Action> _anchored;
+    
+    // Creates a copy of the NFA (or of the reversed NFA) with a new initial
+    // state, which loops on any action.
+    static NFA<Action> prepare(NFA<Action> const& nfa, bool reverse) {
+        std::map<int, int> id;
+        for (int s : nfa.states()) {
+            id.insert({ s, int(id.size()) + 1 });
+        }
+        
+        NFA<Action> result;
+        ActionRange<Action> any(std::numeric_limits<Action>::lowest(),
+                                std::numeric_limits<Action>::max());
+        result.add_transition(0, any, 0);
+        for (auto const& s : id) {
+            for (auto const& t : nfa.transitions(s.first)) {
+                int source = id[s.first];
+                int destination = id[t.destination];
+                if (reverse) {
+                    std::swap(source, destination);
+                }
+                if (t.epsilon) {
+                    result.add_transition(source, destination);
+                } else {
+                    result.add_transition(source, t.filter, destination);
+                }
+            }
+        }
+        
+        if (reverse) {
+            for (int a : nfa.accepting_states()) {
+                result.add_transition(0, id[a]);
+            }
+            result.set_accepting_states({ id[0] });
+        } else {
+            result.add_transition(0, id[0]);
+            std::set<int> accepting_states;
+            for (int a : nfa.accepting_states()) {
+                accepting_states.insert(id[a]);
+            }
+            result.set_accepting_states(accepting_states);
+        }
+        return result;
+    }
+    
+public:
+    struct Match {
+        size_t begin;
+        size_t end;
+    }; // Match
+    
+    Search(NFA<Action> const& nfa)
+    : _forward(DFA<Action>(prepare(nfa, false)))
+    , _reverse(DFA<Action>(prepare(nfa, true)))
+    , _anchored(DFA<Action>(nfa)) {}
+    
+    // Appends the positions at which a match ends, in one pass over the
+    // input. A position is the number of actions before it.
+    template <typename Iterator>
+    void ends(Iterator first,
+              Iterator last,
+              std::vector<size_t>& result) const {
+        int state = _forward.initial();
+        if (_forward.accepted(state)) {
+            result.push_back(0);
+        }
+        size_t position = 0;
+        for (Iterator it = first; it != last; ++it) {
+            // the '.*' prefix never lets the forward DFA fail
+            _forward.successor(state, *it, state);
+            position++;
+            if (_forward.accepted(state)) {
+                result.push_back(position);
+            }
+        }
+    }
+    
+    // Appends the positions at which a match begins in increasing order, in
+    // one backward pass over the input. Requires bidirectional iterators.
+    template <typename Iterator>
+    void starts(Iterator first,
+                Iterator last,
+                std::vector<size_t>& result) const {
+        size_t const appended = result.size();
+        size_t position = size_t(std::distance(first, last));
+        int state = _reverse.initial();
+        if (_reverse.accepted(state)) {
+            result.push_back(position);
+        }
+        for (Iterator it = last; it != first;) {
+            --it;
+            _reverse.successor(state, *it, state);
+            position--;
+            if (_reverse.accepted(state)) {
+                result.push_back(position);
+            }
+        }
+        std::reverse(result.begin() + appended, result.end());
+    }
+    
+    // Appends the leftmost longest matches that do not overlap. An empty
+    // match is only reported if no longer match starts at its position.
+    // Requires bidirectional iterators.
+    //
+    // Finding the end of a match runs until the DFA fails, which may be past
+    // the end of the match. Each action is read a constant number of times
+    // unless this overshoot is long for many matches: a|a*b over a run of n
+    // a's reads the rest of the run for every match, O(n^2) in total.
+    template <typename Iterator>
+    void find_all(Iterator first,
+                  Iterator last,
+                  std::vector<Match>& result) const {
+        std::vector<size_t> positions;
+        starts(first, last, positions);
+        Iterator it = first;
+        size_t position = 0;
+        for (size_t start : positions) {
+            if (start < position) {
+                continue; // inside the previous match
+            }
+            std::advance(it, start - position);
+            position = start;
+            
+            // every start has a match, find the longest one
+            int state = _anchored.initial();
+            Iterator end = it;
+            size_t end_position = position;
+            size_t current = position;
+            for (Iterator next = it; next != last;) {
+                if (!_anchored.successor(state, *next, state)) {
+                    break;
+                }
+                ++next;
+                ++current;
+                if (_anchored.accepted(state)) {
+                    end = next;
+                    end_position = current;
+                }
+            }
+            result.push_back({ start, end_position });
+            it = end;
+            position = end_position;
+        }
+    }
+}; // Search
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif /* defined(__Parser__Search__) */
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,162 @@
+//
+//  SharedFSM.h
+//  FSM
+//
+//  Created by Kristof Niederholtmeyer on 18.10.26.
+//  Copyright (c) 2026 Kristof Niederholtmeyer. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __Parser__SharedFSM__
+#define __Parser__SharedFSM__
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// An automat shared between threads, which can be replaced while others are
+// still evaluating it (read-copy-update).
+//
+// Every evaluating thread owns a Reader. Reader::load() returns the current
+// automat, which stays valid until the reader calls quiescent(), e.g. after
+// each input. Neither call performs an atomic read-modify-write. A replaced
+// automat is freed once every reader has been quiescent since it was replaced.
+// A reader that went offline() has to call online() before its next load().
+template <typename FSM>
+class SharedFSM {
+    typedef std::uint64_t Epoch;
+    static constexpr Epoch Offline = std::numeric_limits<Epoch>::max();
+    
+    struct Retired {
+        FSM const* fsm;
+        Epoch epoch;
+    }; // Retired
+    
+public:
+    class Reader {
+        friend class SharedFSM<FSM>;
+        
+        SharedFSM<FSM>& _shared;
+        // The last epoch the reader has seen while not using any automat.
+        alignas(64) std::atomic<Epoch> _epoch;
+        
+    public:
+        Reader(SharedFSM<FSM>& shared)
+        : _shared(shared), _epoch(Offline) {
+            std::lock_guard<std::mutex> lock(_shared._mutex);
+            _shared._readers.push_back(this);
+            quiescent();
+        }
+        
+        ~Reader() {
+            std::lock_guard<std::mutex> lock(_shared._mutex);
+            auto& readers = _shared._readers;
+            readers.erase(std::find(readers.begin(), readers.end(), this));
+        }
+        
+        Reader(Reader const&) = delete;
+        Reader& operator = (Reader const&) = delete;
+        
+        // Returns the current automat. It stays valid until the next call to
+        // quiescent(). Sequentially consistent to pair with online(), which
+        // costs the same as acquire on common processors.
+        FSM const& load() const {
+            return *_shared._current.load(std::memory_order_seq_cst);
+        }
+        
+        // Declares that no automat returned by load() is used anymore.
+        void quiescent() {
+            _epoch.store(_shared._epoch.load(std::memory_order_acquire),
+                         std::memory_order_release);
+        }
+        
+        // Declares that the reader will not call load() for a while. Writers
+        // do not wait for offline readers.
+        void offline() {
+            _epoch.store(Offline, std::memory_order_release);
+        }
+        
+        // Declares that the reader calls load() again after offline(). The
+        // epoch is stored sequentially consistent, so it cannot become visible
+        // after the next load() and a writer cannot free the automat returned.
+        void online() {
+            _epoch.store(_shared._epoch.load(std::memory_order_acquire),
+                         std::memory_order_seq_cst);
+        }
+    }; // Reader
+    
+private:
+    std::atomic<FSM const*> _current;
+    std::atomic<Epoch> _epoch;
+    std::mutex _mutex;
+    std::vector<Reader*> _readers;
+    std::vector<Retired> _retired;
+    
+public:
+    SharedFSM(std::unique_ptr<FSM const> fsm)
+    : _current(fsm.release()), _epoch(1) {}
+    
+    // All readers have to be destroyed before the shared automat.
+    ~SharedFSM() {
+        delete _current.load();
+        for (Retired const& r : _retired) {
+            delete r.fsm;
+        }
+    }
+    
+    SharedFSM(SharedFSM const&) = delete;
+    SharedFSM& operator = (SharedFSM const&) = delete;
+    
+    // Publishes a new automat. The replaced automat is freed as soon as no
+    // reader can use it anymore.
+    void store(std::unique_ptr<FSM const> fsm) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        FSM const* old = _current.exchange(fsm.release());
+        _retired.push_back({ old, _epoch.fetch_add(1) + 1 });
+        collect();
+    }
+    
+    // Frees replaced automata that are no longer used. Returns the number of
+    // automata still waiting for readers.
+    size_t reclaim() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        collect();
+        return _retired.size();
+    }
+    
+private:
+    void collect() {
+        // Sequentially consistent to pair with Reader::online(): either the
+        // reader loads the replacing automat or the writer sees its epoch.
+        Epoch oldest = Offline;
+        for (Reader const* r : _readers) {
+            oldest = std::min(oldest, r->_epoch.load(std::memory_order_seq_cst));
+        }
+        std::vector<Retired> retired;
+        for (Retired const& r : _retired) {
+            if (r.epoch <= oldest) {
+                delete r.fsm;
+            } else {
+                retired.push_back(r);
+            }
+        }
+        _retired = retired;
+    }
+}; // SharedFSM
+
+template <typename FSM>
+constexpr typename SharedFSM<FSM>::Epoch SharedFSM<FSM>::Offline;
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif /* defined(__Parser__SharedFSM__) */
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,172 @@
+//
+//  SmallVector.h
+//  FSM
+//
+//  Created by Kristof Niederholtmeyer on 18.10.26.
+//  Copyright (c) 2026 Kristof Niederholtmeyer. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __Parser__SmallVector__
+#define __Parser__SmallVector__
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A vector storing up to N elements inside the object itself. Only larger
+// vectors allocate memory.
+template<typename T, size_t N>
+class SmallVector {
+    static constexpr bool nothrow_move = std::is_nothrow_move_constructible<T>::value;
+    
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type _inline[N];
+    T* _data;
+    size_t _size;
+    size_t _capacity;
+    
+    T* inline_data() { return reinterpret_cast<T*>(_inline); }
+    bool on_heap() const { return _capacity > N; }
+    
+    void release() {
+        clear();
+        if (on_heap()) {
+            ::operator delete(_data);
+            _data = inline_data();
+            _capacity = N;
+        }
+    }
+    
+    // Takes over the elements of 'other', leaving it empty.
+    void steal(SmallVector& other) noexcept(nothrow_move) {
+        if (other.on_heap()) {
+            _data = other._data;
+            _size = other._size;
+            _capacity = other._capacity;
+            other._data = other.inline_data();
+            other._size = 0;
+            other._capacity = N;
+        } else {
+            for (size_t i = 0; i < other._size; ++i) {
+                new (_data + i) T(std::move(other._data[i]));
+            }
+            _size = other._size;
+            other.clear();
+        }
+    }
+    
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef T const* const_iterator;
+    
+    SmallVector() : _data(inline_data()), _size(0), _capacity(N) {}
+    
+    SmallVector(std::initializer_list<T> values) : SmallVector() {
+        reserve(values.size());
+        for (T const& value : values) {
+            push_back(value);
+        }
+    }
+    
+    SmallVector(SmallVector const& other) : SmallVector() {
+        reserve(other._size);
+        for (T const& value : other) {
+            push_back(value);
+        }
+    }
+    
+    // Moving does not throw unless moving T does, so containers of small
+    // vectors move them when growing instead of copying.
+    SmallVector(SmallVector&& other) noexcept(nothrow_move) : SmallVector() {
+        steal(other);
+    }
+    
+    ~SmallVector() {
+        release();
+    }
+    
+    SmallVector& operator = (SmallVector const& other) {
+        if (this != &other) {
+            clear();
+            reserve(other._size);
+            for (T const& value : other) {
+                push_back(value);
+            }
+        }
+        return *this;
+    }
+    
+    SmallVector& operator = (SmallVector&& other) noexcept(nothrow_move) {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+    
+    void reserve(size_t capacity) {
+        if (capacity <= _capacity) {
+            return;
+        }
+        T* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+        for (size_t i = 0; i < _size; ++i) {
+            new (data + i) T(std::move(_data[i]));
+            _data[i].~T();
+        }
+        if (on_heap()) {
+            ::operator delete(_data);
+        }
+        _data = data;
+        _capacity = capacity;
+    }
+    
+    void push_back(T const& value) {
+        if (_size == _capacity) {
+            T copy(value); // value might be an element
+            reserve(2 * _capacity);
+            new (_data + _size) T(std::move(copy));
+        } else {
+            new (_data + _size) T(value);
+        }
+        _size++;
+    }
+    
+    void pop_back() {
+        _data[--_size].~T();
+    }
+    
+    void clear() {
+        while (_size > 0) {
+            pop_back();
+        }
+    }
+    
+    size_t size() const { return _size; }
+    size_t capacity() const { return _capacity; }
+    bool empty() const { return _size == 0; }
+    
+    T& operator [] (size_t i) { return _data[i]; }
+    T const& operator [] (size_t i) const { return _data[i]; }
+    T& front() { return _data[0]; }
+    T const& front() const { return _data[0]; }
+    T& back() { return _data[_size - 1]; }
+    T const& back() const { return _data[_size - 1]; }
+    
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+}; // SmallVector
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif /* defined(__Parser__SmallVector__) */
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,187 @@
+//
+//  SparseNFA.h
+//  FSM
+//
+//  Created by Kristof Niederholtmeyer on 18.10.26.
+//  Copyright (c) 2026 Kristof Niederholtmeyer. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __Parser__SparseNFA__
+#define __Parser__SparseNFA__
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "NFA.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// A read only NFA prepared for fast evaluation. The states are renumbered
+// from 0 and the transitions leaving a state are stored consecutively
+// (compressed sparse rows), separately for epsilon and filtered transitions.
+//
+// The active states are kept in a sparse set (Briggs and Torczon): a list of
+// the active states plus an index from each state to its position in the
+// list. Testing, adding and clearing take constant time, so a step only
+// costs time proportional to the number of active states and the
+// transitions leaving them. The index is allocated by the first step of an
+// evaluation and kept by reset(), so resetting an Evaluator costs time
+// proportional to the number of initial states.
+template <typename Action>
+class SparseNFA {
+    typedef ActionFilter<Action> Filter;
+    
+public:
+    // Type definitions for the Evaluator
+    struct EvaluationState {
+        std::vector<int> active; // The active states in order of priority
+        bool accepting;
+        
+        // Used while performing a transition
+        std::vector<int> index;
+        std::vector<int> next;
+        std::vector<int> stack;
+    }; // EvaluationState
+    typedef Action EvaluationAction;
+    
+private:
+    std::vector<int> _states; // NFA state of each state
+    std::vector<int> _epsilon_offsets;
+    std::vector<int> _epsilon_destinations;
+    std::vector<int> _offsets;
+    std::vector<int> _destinations;
+    std::vector<Filter> _filters;
+    std::vector<char> _accepting;
+    std::vector<int> _initial;
+    bool _initial_accepting;
+    
+    // Adds the state and all states reachable from it by epsilon transitions
+    // to the sparse set. Returns true if an accepting state was added.
+    bool closure(int state,
+                 std::vector<int>& index,
+                 std::vector<int>& set,
+                 std::vector<int>& stack) const {
+        bool accepting = false;
+        stack.push_back(state);
+        while (!stack.empty()) {
+            int s = stack.back();
+            stack.pop_back();
+            size_t i = size_t(index[s]);
+            if (i < set.size() && set[i] == s) {
+                continue;
+            }
+            index[s] = int(set.size());
+            set.push_back(s);
+            accepting = accepting || _accepting[s];
+            // push in reverse to visit the transitions in their order
+            for (int e = _epsilon_offsets[s + 1]; e > _epsilon_offsets[s]; --e) {
+                stack.push_back(_epsilon_destinations[e - 1]);
+            }
+        }
+        return accepting;
+    }
+    
+    void prepare(EvaluationState& state) const {
+        if (state.index.size() != _states.size()) {
+            state.index.assign(_states.size(), 0);
+            state.next.reserve(_states.size());
+            state.active.reserve(_states.size());
+        }
+    }
+    
+public:
+    SparseNFA(NFA<Action> const& nfa) {
+        std::map<int, int> dense;
+        for (int s : nfa.states()) {
+            dense.insert({ s, int(_states.size()) });
+            _states.push_back(s);
+        }
+        
+        _epsilon_offsets.push_back(0);
+        _offsets.push_back(0);
+        for (int s : _states) {
+            for (auto const& t : nfa.transitions(s)) {
+                if (t.epsilon) {
+                    _epsilon_destinations.push_back(dense[t.destination]);
+                } else {
+                    _destinations.push_back(dense[t.destination]);
+                    _filters.push_back(t.filter);
+                }
+            }
+            _epsilon_offsets.push_back(int(_epsilon_destinations.size()));
+            _offsets.push_back(int(_destinations.size()));
+            _accepting.push_back(nfa.accepted({ s }));
+        }
+        
+        EvaluationState state;
+        prepare(state);
+        _initial_accepting = closure(dense[0], state.index, _initial,
+                                     state.stack);
+    }
+    
+    // Creates the set of states reachable by the action. If no such state
+    // exists, the method returns false and the output stays unchanged.
+    bool successor(EvaluationState const& from,
+                   EvaluationAction const& action,
+                   EvaluationState& output) const {
+        prepare(output);
+        output.next.clear();
+        bool accepting = false;
+        for (int s : from.active) {
+            for (int e = _offsets[s]; e < _offsets[s + 1]; ++e) {
+                if (_filters[e].includes(action)) {
+                    accepting = closure(_destinations[e], output.index,
+                                        output.next, output.stack) || accepting;
+                }
+            }
+        }
+        if (output.next.empty()) {
+            return false;
+        }
+        std::swap(output.active, output.next);
+        output.accepting = accepting;
+        return true;
+    }
+    
+    // Returns true if one of the states is an accepting state.
+    bool accepted(EvaluationState const& state) const {
+        return state.accepting;
+    }
+    
+    // Returns the initial set of states.
+    EvaluationState initial() const {
+        return { _initial, _initial_accepting, {}, {}, {} };
+    }
+    
+    // Sets the state to the initial set of states, keeping the memory it
+    // uses while performing transitions.
+    void reset(EvaluationState& state) const {
+        state.active = _initial;
+        state.accepting = _initial_accepting;
+    }
+    
+    // Returns the NFA states of the set of states.
+    std::set<int> states(EvaluationState const& state) const {
+        std::set<int> result;
+        for (int s : state.active) {
+            result.insert(_states[s]);
+        }
+        return result;
+    }
+    
+    // Returns the number of states.
+    size_t size() const {
+        return _states.size();
+    }
+}; // SparseNFA
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif /* defined(__Parser__SparseNFA__) */
+
+////////////////////////////////////////////////////////////////////////////////
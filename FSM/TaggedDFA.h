@@ -0,0 +1,280 @@
+//
+//  TaggedDFA.h
+//  FSM
+//
+//  Created by Kristof Niederholtmeyer on 18.10.26.
+//  Copyright (c) 2026 Kristof Niederholtmeyer. All rights reserved.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __Parser__TaggedDFA__
+#define __Parser__TaggedDFA__
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "NFA.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Deterministic Finite Automat with tags (Laurikari). While evaluating, it
+// records the positions at which the tagged transitions of its NFA were
+// passed, so capture groups are known after a single pass over the input.
+//
+// A state is an ordered list of threads. A thread is a filtered transition
+// of the NFA, or an accepting NFA state. The order encodes the priority of
+// the threads: transitions added earlier to the NFA win over later ones, like
+// in backtracking regular expression engines. An accepting state counts as
+// if it were tested before its transitions. Each thread owns a fixed slot of
+// registers, one per tag. A transition copies the registers of the thread
+// each new thread descends from and stores the current position in the tags
+// passed on the way.
+template <typename Action>
+class TaggedDFA {
+    typedef int State;
+    typedef std::set<int> StateSet;
+    // The NFA state and the index of its filtered transition, or -1 for an
+    // accepting NFA state.
+    typedef std::pair<int, int> Thread;
+    typedef std::vector<Thread> Threads;
+    typedef ActionFilter<Action> Filter;
+    typedef typename NFA<Action>::Transition NFATransition;
+    
+    // Copies the registers of slot 'from' to slot 'to' (resets them if 'from'
+    // is -1) and records the current position in the given tags.
+    struct Operation {
+        int to;
+        int from;
+        std::vector<int> tags;
+    }; // Operation
+    typedef std::vector<Operation> Operations;
+    
+    struct Transition {
+        State destination;
+        Filter filter;
+        Operations operations;
+    }; // Transition
+    typedef std::vector<Transition> Transitions;
+    
+public:
+    // Type definitions for the Evaluator
+    struct EvaluationState {
+        State state;
+        int position;
+        std::vector<int> registers;
+        std::vector<int> scratch; // Used while performing a transition
+    }; // EvaluationState
+    typedef Action EvaluationAction;
+    
+private:
+    std::vector<Transitions> _transition_table;
+    std::vector<int> _accepting_slots;
+    Operations _initial_operations;
+    int _tag_count;
+    size_t _slot_count;
+    
+    // Appends the threads reachable by epsilon transitions from the NFA state
+    // in order of priority. The transitions of every state are followed in
+    // the order they were added, depth first; a state reached again is
+    // skipped, as its first visit has the higher priority.
+    static void closure(NFA<Action> const& nfa,
+                        int from,
+                        int state,
+                        StateSet& visited,
+                        Threads& threads,
+                        Operations& operations) {
+        struct Visit {
+            int state;
+            size_t next; // The next transition to follow
+            std::vector<int> tags;
+        }; // Visit
+        std::vector<Visit> stack;
+        auto enter = [&](int s, std::vector<int> const& tags) {
+            if (!visited.insert(s).second) {
+                return;
+            }
+            if (nfa.accepted({ s })) {
+                operations.push_back({ int(threads.size()), from, tags });
+                threads.push_back({ s, -1 });
+            }
+            stack.push_back({ s, 0, tags });
+        };
+        
+        enter(state, {});
+        while (!stack.empty()) {
+            Visit& current = stack.back();
+            auto const& transitions = nfa.transitions(current.state);
+            if (current.next == transitions.size()) {
+                stack.pop_back();
+                continue;
+            }
+            int const index = int(current.next++);
+            auto const& t = transitions[index];
+            if (!t.epsilon) {
+                operations.push_back({ int(threads.size()), from, current.tags });
+                threads.push_back({ current.state, index });
+                continue;
+            }
+            std::vector<int> tags = current.tags;
+            if (t.tag >= 0) {
+                tags.push_back(t.tag);
+            }
+            enter(t.destination, tags);
+        }
+    }
+    
+    // Returns the filtered NFA transition of the thread.
+    static NFATransition const& transition(NFA<Action> const& nfa,
+                                           Thread const& thread) {
+        return nfa.transitions(thread.first)[thread.second];
+    }
+    
+    void apply(Operations const& operations,
+               std::vector<int> const& from,
+               std::vector<int>& to,
+               int position) const {
+        to.resize(_slot_count * _tag_count);
+        for (Operation const& o : operations) {
+            int* r = to.data() + o.to * _tag_count;
+            if (o.from >= 0) {
+                std::copy(from.begin() + o.from * _tag_count,
+                          from.begin() + (o.from + 1) * _tag_count, r);
+            } else {
+                std::fill(r, r + _tag_count, -1);
+            }
+            for (int tag : o.tags) {
+                r[tag] = position;
+            }
+        }
+    }
+    
+public:
+    TaggedDFA(NFA<Action> const& nfa)
+    : _tag_count(nfa.tags()), _slot_count(0) {
+        std::vector<Threads> states(1);
+        StateSet visited;
+        closure(nfa, -1, 0, visited, states[0], _initial_operations);
+        std::map<Threads, State> index{ { states[0], 0 } };
+        
+        for (size_t current = 0; current < states.size(); ++current) {
+            Threads const threads = states[current];
+            _slot_count = std::max(_slot_count, threads.size());
+            
+            int accepting_slot = -1;
+            std::vector<Filter> filters;
+            for (size_t i = 0; i < threads.size(); ++i) {
+                if (threads[i].second < 0) {
+                    if (accepting_slot < 0) {
+                        accepting_slot = int(i);
+                    }
+                } else {
+                    filters.push_back(transition(nfa, threads[i]).filter);
+                }
+            }
+            _accepting_slots.push_back(accepting_slot);
+            
+            Transitions transitions;
+            for (Filter const& f : atomize(filters)) {
+                Threads next;
+                Operations operations;
+                visited.clear();
+                for (size_t i = 0; i < threads.size(); ++i) {
+                    if (threads[i].second >= 0) {
+                        auto const& t = transition(nfa, threads[i]);
+                        if (t.filter.includes(f)) {
+                            closure(nfa, int(i), t.destination, visited,
+                                    next, operations);
+                        }
+                    }
+                }
+                if (next.empty()) {
+                    continue;
+                }
+                auto it = index.find(next);
+                if (it == index.end()) {
+                    it = index.insert({ next, State(states.size()) }).first;
+                    states.push_back(next);
+                }
+                transitions.push_back({ it->second, f, operations });
+            }
+            _transition_table.push_back(transitions);
+        }
+    }
+    
+    // Finds the state reachable by the action. If no such state exists, the
+    // method returns false and the output stays unchanged.
+    bool successor(EvaluationState const& from,
+                   EvaluationAction const& action,
+                   EvaluationState& output) const {
+        for (Transition const& t : _transition_table[from.state]) {
+            if (t.filter.includes(action)) {
+                int position = from.position + 1;
+                apply(t.operations, from.registers, output.scratch, position);
+                std::swap(output.registers, output.scratch);
+                output.state = t.destination;
+                output.position = position;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // Returns true if the state is an accepting state.
+    bool accepted(EvaluationState const& state) const {
+        return _accepting_slots[state.state] >= 0;
+    }
+    
+    // Returns the initial state.
+    EvaluationState initial() const {
+        EvaluationState state{ 0, 0, {}, {} };
+        apply(_initial_operations, state.scratch, state.registers, 0);
+        return state;
+    }
+    
+    // Returns the position recorded for the tag by the accepting thread, or -1
+    // if the state is not accepting or the tag was not passed.
+    int tag(EvaluationState const& state, int tag) const {
+        int slot = _accepting_slots[state.state];
+        if (slot < 0 || tag < 0 || tag >= _tag_count) {
+            return -1;
+        }
+        return state.registers[slot * _tag_count + tag];
+    }
+    
+    // Returns the range of actions matched by capture group n (tags 2n and
+    // 2n+1). Returns false if the group did not take part in the match.
+    bool capture(EvaluationState const& state,
+                 int group,
+                 int& begin,
+                 int& end) const {
+        int b = tag(state, 2 * group);
+        int e = tag(state, 2 * group + 1);
+        if (b < 0 || e < 0) {
+            return false;
+        }
+        begin = b;
+        end = e;
+        return true;
+    }
+    
+    // Returns the number of tags.
+    int tags() const {
+        return _tag_count;
+    }
+    
+    // Returns the number of states.
+    size_t size() const {
+        return _transition_table.size();
+    }
+}; // TaggedDFA
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif /* defined(__Parser__TaggedDFA__) */
+
+////////////////////////////////////////////////////////////////////////////////
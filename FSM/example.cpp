@@ -12,6 +12,7 @@
 #include "NFA.h"
 #include "DFA.h"
 #include "Evaluator.h"
+#include "TaggedDFA.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -73,6 +74,31 @@ int main(int argc, const char * argv[])
     std::cout << std::endl;
     std::cout << number_dfa.graphviz("number_dfa") << std::endl;
     
+    // Capture groups are marked by tagged transitions: group n starts at tag
+    // 2n and ends at tag 2n+1. Transitions added earlier are preferred, so
+    // leaving the loop of state 1 first makes it lazy: (a*?)(a*)
+    CharNFA lazy_nfa;
+    lazy_nfa.add_tagged_transition(0, 0, 1);
+    lazy_nfa.add_tagged_transition(1, 1, 2); // leave the lazy loop first
+    lazy_nfa.add_transition(1, CharFilter('a'), 1);
+    lazy_nfa.add_tagged_transition(2, 2, 3);
+    lazy_nfa.add_transition(3, CharFilter('a'), 3);
+    lazy_nfa.add_tagged_transition(3, 3, 4);
+    lazy_nfa.set_accepting_states({4});
+    
+    // Evaluating "aa" leaves the first group empty: [0, 0) and [0, 2)
+    TaggedDFA<char> lazy_dfa(lazy_nfa);
+    Evaluator<TaggedDFA<char>> evaluator_lazy(lazy_dfa);
+    evaluator_lazy.perform('a');
+    evaluator_lazy.perform('a');
+    for (int group = 0; group < 2; ++group) {
+        int begin = 0;
+        int end = 0;
+        if (lazy_dfa.capture(evaluator_lazy.state(), group, begin, end)) {
+            std::cout << "Group " << group << ": [" << begin << ", " << end << ")" << std::endl;
+        }
+    }
+    
     // Evaluation (works for both, NFAs and DFAs)
     CharNFAEvaluator evaluator_nfa(number_nfa);
     std::string string;